@@ -8,8 +8,11 @@
 #ifndef	_DEFS_H
 #define	_DEFS_H	1
 #define _DEBUG 1
+#include <stdio.h>
+#include <sys/types.h>
 #include <sys/stat.h>
 #include <limits.h>
+#include <fnmatch.h>
 
 #define MYFIND_USER 1
 #define MYFIND_NAME 2
@@ -19,6 +22,22 @@
 #define MYFIND_MAXDEPTH 32
 #define MYFIND_HELP 64
 #define MYFIND_ISFILE 128		// already filename-input before -name ?
+#define MYFIND_DEPTH 256		// post-order: list the content of a directory before the directory itself
+#define MYFIND_BFS 512			// breadth-first instead of depth-first
+#define MYFIND_MAXQUEUE 1024	// number of pending entries kept in memory before spilling to disk
+#define MYFIND_QUIT 2048		// stop after the first match
+#define MYFIND_LIMIT 4096		// stop after N matches
+#define MYFIND_TOP 8192			// only output the N largest/newest matches
+#define MYFIND_BY 16384			// sort key for -top
+#define MYFIND_FPRINT 32768		// output to a file instead of stdout
+#define MYFIND_QUERIES 65536	// one search, many expressions (one per line of a file)
+
+#define MYFIND_QUEUE_DEFAULT 65536	// default for -maxqueue
+
+#define MYFIND_BY_SIZE 1
+#define MYFIND_BY_MTIME 2
+
+#define MYFIND_FNM_FLAGS (FNM_NOESCAPE | FNM_PERIOD)	// flags of fnmatch() for -name
 
 /**
  * @struct myfind
@@ -31,11 +50,35 @@ struct myfind {
 	struct fileinfo *fileinfo;			// names of files, directory or link
 	struct mypredicate *mypred;			// arguments to describe the file and search-mode (after path)
 	int maxdepth;						// how deep do we search the directory-tree?
+	long maxqueue;						// max. pending entries in memory, the rest goes to a temp file
 	char *name;
 	char *type;
 	char *user;
+	uid_t uid;							// -user resolved once before the search starts
+	long limit;							// -limit/-quit: stop after this many matches, 0 = no limit
+	long found;							// matches so far
+	int done;							// 1 = answer is complete, stop the search
+	struct topk *top;					// -top: best matches so far
+	char *fprint;						// -fprint: name of the output file
+	FILE *out;							// output, stdout unless -fprint or --queries
+	struct query *queries;				// --queries: one task per line of the file
+	struct testcache *cache;			// --queries: results of the tests shared by all lines
 	char path[PATH_MAX];				// path to working directory
 };
+/**
+ * @struct query
+ * @brief --queries: one line of the file
+ *
+ */
+struct query {
+	struct myfind task;					// parsed expression of the line
+	struct query *next;
+	int lineno;							// line in the file, for error messages
+	int nameidx;						// position of -name in the cache
+	char *line;							// text of the line, the arguments point into it
+	char **argv;						// arguments as given to parse_arguments()
+	char *outname;						// FILE.N, if the line has no -fprint
+};
 /**
  * @struct options
  * @brief List of the known predicates
@@ -71,17 +114,98 @@ struct arguments {
 	char *argument;
 	struct arguments *next;
 };
+/**
+ * @struct testcache
+ * @brief --queries: every distinct -name pattern once, evaluated at most once per entry
+ *
+ */
+struct testcache {
+	char **names;			// distinct patterns
+	int count;
+	char *hit;				// result of names[i] for the current entry...
+	long *stamp;			// ...valid if stamp[i] == gen
+	long gen;				// number of the current entry
+};
+/**
+ * @struct topentry
+ * @brief one match kept by -top
+ *
+ */
+struct topentry {
+	long long key;			// size or mtime in ns
+	struct stat filestat;
+	char *name;
+};
+/**
+ * @struct topk
+ * @brief min-heap of the max best matches, heap[0] is the first one to drop
+ *
+ */
+struct topk {
+	struct topentry *heap;
+	long size;				// entries in the heap
+	long cap;				// allocated entries, grows up to max
+	long max;				// N of -top
+	int by;					// MYFIND_BY_SIZE or MYFIND_BY_MTIME
+};
+/**
+ * @struct dirnode
+ * @brief pending entry of the traversal (file, directory or link not yet visited)
+ *
+ */
+struct dirnode {
+	struct dirnode *next;
+	struct dirnode *prev;
+	int depth;				// position in dir hierarchy, 0 = starting point
+	char post;				// 1 = content already listed, only output the directory (-depth)
+	char name[];			// full path
+};
+/**
+ * @struct dirqueue
+ * @brief frontier of the traversal, fifo for -bfs, stack otherwise
+ *
+ * Holds at most limit entries in memory, everything beyond is written to
+ * an unnamed temp file and read back when the memory part runs empty.
+ */
+struct dirqueue {
+	struct dirnode *head;	// oldest entry in memory
+	struct dirnode *tail;	// newest entry in memory
+	long count;				// entries in memory
+	long limit;				// max. entries in memory
+	int lifo;				// 1 = stack (depth-first), 0 = fifo (breadth-first)
+	int error;				// set, if the temp file failed
+	FILE *spill;			// temp file, opened on first use
+	long spilled;			// entries in the temp file
+	long rpos;				// fifo: next record to read
+	long wpos;				// end of the valid records
+};
 
 int find_end_of_link_opt(struct myfind *, int , char **);
 int test_expression(const char *);
 int parse_arguments(struct myfind *, int, char **, int);
 int get_filenames(struct myfind *, char *, int, char **, int, int);
 void freeMemory(struct myfind *);
-int do_dir(struct myfind *, char *, int, int, short);
+int do_dir(struct myfind *, char *);
 int do_entry(struct myfind *);
+int set_predicates(struct myfind *);
+int eval_entry(struct myfind *, char *, struct stat *, int, int);
+int open_output(struct myfind *);
+char *base_name(char *);
 char *glob_pattern(char *);
 void printHelp();
 int doesitmatch(struct myfind *, char *, int);
 int print_lstat(struct myfind *, struct stat *, char *);
+int queue_init(struct dirqueue *, long, int);
+int queue_push(struct dirqueue *, const char *, int, char);
+struct dirnode *queue_pop(struct dirqueue *);
+void queue_free(struct dirqueue *);
+struct topk *topk_new(long, int);
+int topk_add(struct topk *, char *, struct stat *);
+int topk_print(struct myfind *, struct topk *);
+void topk_free(struct topk *);
+int load_queries(struct myfind *, char *);
+int eval_queries(struct myfind *, char *, struct stat *, int);
+int cache_name(struct testcache *, int, char *);
+void free_queries(struct myfind *);
 
 #endif /* DEFS_H_ */
@@ -13,21 +13,196 @@
 #include <unistd.h>
 #include <pwd.h>
 #include <grp.h>
+#include <errno.h>
 #include "defs.h"
 
 /**
- * @brief
+ * @brief search all starting points given by the user
  *
  */
 int do_entry(struct myfind *task){
 	struct fileinfo *f_info = task->fileinfo;
-	while(f_info != NULL){
-		do_dir(task, f_info->name, task->maxdepth, 0, 1);
+	struct query *query;
+
+	if(!set_predicates(task) || !open_output(task)) return 0;
+	while(f_info != NULL && !task->done){						// -quit/-limit may end the search early
+		if(!do_dir(task, f_info->name)) return 0;
 		f_info = f_info->next;
 	}
+	if(task->top) topk_print(task, task->top);
+	for(query = task->queries; query != NULL; query = query->next){		// --queries: each line has its own -top
+		if(query->task.top) topk_print(&query->task, query->task.top);
+	}
+	return 1;
+}
+/**
+ * @brief take over the arguments of the tests, check them once before the search starts
+ *
+ */
+int set_predicates(struct myfind *task){
+	struct mypredicate *pred = task->mypred;
+	struct passwd *pw;
+	char *end;
+	int indx = 0, by = MYFIND_BY_SIZE;
+	long top = 0, limit;
+	char *optn[] = {"-name", "-user", "-type"};
+
+	while(pred != NULL){
+		switch(pred->predicate){
+			case MYFIND_USER:
+				task->user = pred->args->argument;
+				if((pw = getpwnam(task->user)) != NULL) {
+					task->uid = pw->pw_uid;
+				} else {
+					task->uid = (uid_t)strtoul(task->user, &end, 10);			// not a name, maybe the numeric id
+					if(*end != '\0' || end == task->user){
+						printf("myfind: `%s' is not the name of a known user\n", task->user);
+						return 0;
+					}
+				}
+				break;
+			case MYFIND_TYPE:
+				task->type = pred->args->argument;
+				if(strlen(task->type) != 1 || strchr("bcdpfls", task->type[0]) == NULL){
+					printf("myfind: Unknown argument to -type: %s\n", task->type);
+					return 0;
+				}
+				break;
+			case MYFIND_NAME:
+				task->name = pred->args->argument;
+				break;
+			case MYFIND_MAXDEPTH:											// give warning, if mxdepth isn't on first position
+				if(task->name) indx = 0; else if(task->user) indx = 1; else if(task->type) indx = 2;
+				if(task->user || task->type || task->name) {
+					printf("find: warning: you have specified the -maxdepth option after a non-option argument %s, but options are not positional (-maxdepth affects tests specified before it as well as those specified after it). Please specify options before other arguments.\n",optn[indx]);
+				}
+				break;
+			case MYFIND_MAXQUEUE:
+				errno = 0;
+				task->maxqueue = strtol(pred->args->argument, &end, 10);
+				if(*end != '\0' || end == pred->args->argument || errno == ERANGE || task->maxqueue < 2){	// stack keeps half of it in memory
+					printf("myfind: invalid argument `%s' to `-maxqueue', at least 2 entries\n", pred->args->argument);
+					return 0;
+				}
+				break;
+			case MYFIND_QUIT:
+				task->limit = 1;
+				break;
+			case MYFIND_LIMIT:
+				errno = 0;
+				limit = strtol(pred->args->argument, &end, 10);
+				if(*end != '\0' || end == pred->args->argument || errno == ERANGE || limit <= 0){
+					printf("myfind: invalid argument `%s' to `-limit'\n", pred->args->argument);
+					return 0;
+				}
+				if(task->limit == 0) task->limit = limit;						// -quit wins over -limit
+				break;
+			case MYFIND_TOP:
+				errno = 0;
+				top = strtol(pred->args->argument, &end, 10);
+				if(*end != '\0' || end == pred->args->argument || errno == ERANGE || top <= 0){
+					printf("myfind: invalid argument `%s' to `-top'\n", pred->args->argument);
+					return 0;
+				}
+				break;
+			case MYFIND_FPRINT:
+				task->fprint = pred->args->argument;						// opened by open_output(), once everything is checked
+				break;
+			case MYFIND_BY:
+				if(!strcmp(pred->args->argument, "size")) by = MYFIND_BY_SIZE;
+				else if(!strcmp(pred->args->argument, "mtime")) by = MYFIND_BY_MTIME;
+				else {
+					printf("myfind: invalid argument `%s' to `-by', use size or mtime\n", pred->args->argument);
+					return 0;
+				}
+				break;
+			default:
+				break;
+		}
+		pred = pred->next;
+	}
+	if((task->predicate & (MYFIND_DEPTH | MYFIND_BFS)) == (MYFIND_DEPTH | MYFIND_BFS)){
+		puts("myfind: -depth can't be combined with -bfs");
+		return 0;
+	}
+	if((task->predicate & MYFIND_BY) && !(task->predicate & MYFIND_TOP)){
+		puts("myfind: -by only works together with -top");
+		return 0;
+	}
+	if(top){
+		if(task->limit){
+			puts("myfind: -top can't be combined with -limit or -quit");
+			return 0;
+		}
+		if((task->top = topk_new(top, by)) == NULL){
+			puts("myfind: out of memory\n");
+			return 0;
+		}
+	}
+	if(task->predicate & MYFIND_QUERIES){									// tests and actions come from the file
+		if(task->predicate & (MYFIND_USER | MYFIND_NAME | MYFIND_TYPE | MYFIND_PRINT | MYFIND_LS | MYFIND_QUIT | MYFIND_LIMIT | MYFIND_TOP | MYFIND_FPRINT)){
+			puts("myfind: --queries only allows -maxdepth, -depth, -bfs and -maxqueue on the command line");
+			return 0;
+		}
+		for(pred = task->mypred; pred->predicate != MYFIND_QUERIES; pred = pred->next);
+		return load_queries(task, pred->args->argument);
+	}
 	return 1;
 }
+/**
+ * @brief open the file of -fprint, stdout without it
+ *
+ */
+int open_output(struct myfind *task){
+	if(task->fprint == NULL){
+		task->out = stdout;
+		return 1;
+	}
+	if((task->out = fopen(task->fprint, "w")) == NULL){
+		printf("myfind: ‘%s’: Permission denied\n", task->fprint);
+		return 0;
+	}
+	return 1;
+}
+/**
+ * @brief last part of a path, the path itself for "/" or "."
+ *
+ */
+char *base_name(char *fname){
+	char *base = strrchr(fname, '/');
 
+	return (base == NULL || base[1] == '\0') ? fname : base + 1;
+}
+/**
+ * @brief apply the tests to one entry and output it, if all of them match
+ *
+ * @param namehit	result of -name if already known (--queries), -1 otherwise
+ * @return 0 on error (out of memory), 1 otherwise, matching or not
+ */
+int eval_entry(struct myfind *task, char *fname, struct stat *attribut, int depth, int namehit){
+	char kind;
+
+	if(task->maxdepth && depth > task->maxdepth) return 1;				// --queries: the search may go deeper than this line
+	if(task->name){
+		if(namehit < 0) namehit = doesitmatch(task, base_name(fname), MYFIND_NAME);
+		if(!namehit) return 1;
+	}
+	if(task->user && attribut->st_uid != task->uid) return 1;
+	if(task->type){
+		if(S_ISDIR(attribut->st_mode)) kind = 'd';
+		else if(S_ISLNK(attribut->st_mode)) kind = 'l';
+		else if(S_ISCHR(attribut->st_mode)) kind = 'c';
+		else if(S_ISBLK(attribut->st_mode)) kind = 'b';
+		else if(S_ISFIFO(attribut->st_mode)) kind = 'p';
+		else if(S_ISSOCK(attribut->st_mode)) kind = 's';
+		else kind = 'f';
+		if(kind != task->type[0]) return 1;
+	}
+	task->found++;
+	if(task->limit && task->found >= task->limit) task->done = 1;		// answer complete, stop the search
+	if(task->top) return topk_add(task->top, fname, attribut);			// output at the end of the search
+	return print_lstat(task, attribut, fname);
+}
 int print_lstat(struct myfind *task, struct stat *attribut, char *fname){
 	const char *rwx = "rwxrwxrwx";
 	char l_rwx[11], linkbuf[PATH_MAX];
@@ -40,12 +215,10 @@ int print_lstat(struct myfind *task, struct stat *attribut, char *fname){
 	 S_IRGRP,S_IWGRP,S_IXGRP,// Zugriffsrechte Gruppe
 	 S_IROTH,S_IWOTH,S_IXOTH // Zugriffsrechte der Rest
 	};
+	ssize_t len;
+
 	l_rwx[0] = '-';
 	l_rwx[10] = '\0';
-	if((lstat(fname, attribut)) == -1) {
-		printf("Fehler bei stat (%s)\n", fname);
-		return 0;
-	}
 	if(task->predicate & MYFIND_LS){						// option "-ls" for output?
 		pw = getpwuid(attribut->st_uid);
 		grp = getgrgid(attribut->st_gid);
@@ -57,95 +230,94 @@ int print_lstat(struct myfind *task, struct stat *attribut, char *fname){
 			l_rwx[i+1]=(attribut->st_mode & bits[i]) ? rwx[i] : '-';
 		}
 		l_rwx[10]='\0';
-		printf("%9lu%7lu%11s%4lu %10s %10s %-40s", attribut->st_ino, attribut->st_blocks/2, l_rwx, attribut->st_nlink, pw->pw_name, grp->gr_name, fname);
+		fprintf(task->out, "%9lu%7lu%11s%4lu ", attribut->st_ino, attribut->st_blocks/2, l_rwx, attribut->st_nlink);
+		if(pw) fprintf(task->out, "%10s ", pw->pw_name); else fprintf(task->out, "%10u ", attribut->st_uid);
+		if(grp) fprintf(task->out, "%10s ", grp->gr_name); else fprintf(task->out, "%10u ", attribut->st_gid);
+		fprintf(task->out, "%-40s", fname);
 	} else {
-		printf("%-40s ", fname);
+		fprintf(task->out, "%-40s ", fname);
 	}
-	if( S_ISLNK(attribut->st_mode) ) {
-		readlink(fname, linkbuf, PATH_MAX);
-		linkbuf[attribut->st_size] = '\0';
-		printf(" %s", linkbuf);
+	if( S_ISLNK(attribut->st_mode) && (len = readlink(fname, linkbuf, PATH_MAX - 1)) >= 0) {
+		linkbuf[len] = '\0';
+		fprintf(task->out, " %s", linkbuf);
 	}
-	puts(" ");
+	fputs(" \n", task->out);
 	return 1;
 }
 /**
- * @brief list a directory
- * 
+ * @brief put the content of a directory into the frontier
+ *
+ * The directory is read in one go and closed again, so only one directory is
+ * open at a time, no matter how deep the tree is.
  */
-int do_dir(struct myfind *task, char *dir_name, int maxdepth, int depth, short flag) {
+static int read_dir(struct dirqueue *queue, struct dirnode *node){
 	DIR *dir;
-	char fname[PATH_MAX];
 	struct dirent *dirzeiger;
-	struct stat attribut;
-	struct mypredicate *pred = task->mypred;
-	int ls, indx;
-	char *optn[] = {"-name", "-user", "-type"};
-
-	depth++;						// increase position in dir hierarchy
+	char fname[PATH_MAX];
+	size_t len;
+	char *sep;
 
-	// open directory
-	if((dir=opendir(dir_name)) == NULL) {
-		printf("myfind: ‘%s’: Permission denied\n",dir_name);
-	return 0;
+	if((dir=opendir(node->name)) == NULL) {
+		printf("myfind: ‘%s’: Permission denied\n",node->name);
+		return 1;													// not fatal, go on with the next one
 	}
-	// read the directory
-	ls = 0;
+	len = strlen(node->name);
+	sep = (len > 0 && node->name[len - 1] == '/') ? "" : "/";
 	while((dirzeiger=readdir(dir)) != NULL) {
-		if(strcmp("..", dirzeiger->d_name) && strcmp(".", dirzeiger->d_name) &&(doesitmatch(task, dirzeiger->d_name, MYFIND_NAME))) {
-
-
-
-			while(pred != NULL && !ls){
-				switch(pred->predicate){
-					case MYFIND_USER:
-						if(task->user != NULL) return 0;
-						task->user = pred->args->argument;
-						break;
-					case MYFIND_TYPE:
-						if(task->type != NULL) return 0;
-						task->type = pred->args->argument;
-						break;
-					case MYFIND_NAME:
-						if(task->name != NULL) return 0;
-						task->name = pred->args->argument;
-						break;
-					case MYFIND_LS:
-						ls = 1;
-						break;
-					case MYFIND_MAXDEPTH:
-						maxdepth = atoi(pred->args->argument);				// give warning, if mxdepth isn't on first position
-						if(task->name) indx = 0; else if(task->user) indx = 1; else if(task->type) indx = 2;
-						if(task->user || task->type || task->name) {
-							printf("find: warning: you have specified the -maxdepth option after a non-option argument %s, but options are not positional (-maxdepth affects tests specified before it as well as those specified after it). Please specify options before other arguments.\n",optn[indx]);
-						}
-						break;
-					default:
-						return 0;		// unknown type
-						break;
-				}
-				if(ls){
-					if(flag){
-					if(!print_lstat(task, &attribut, dir_name)) return 0;			// output info for startdir at the first call
-					flag = 0;
-					}
-					memset(&fname[0], 0, PATH_MAX);
-					strcpy(&fname[0],dir_name);
-					strcat(&fname[0], "/");
-					strcat(&fname[0], dirzeiger->d_name);
-
-					if(!print_lstat(task, &attribut, &fname[0])) return 0;
-
-					if(S_ISDIR(attribut.st_mode)) {
-						if(depth < maxdepth || maxdepth == 0) {
-							do_dir(task, &fname[0], maxdepth, depth, 0);
-						}
-					}
-				}
-				pred = pred->next;
-			}
+		if(!strcmp("..", dirzeiger->d_name) || !strcmp(".", dirzeiger->d_name)) continue;
+		if(snprintf(fname, PATH_MAX, "%s%s%s", node->name, sep, dirzeiger->d_name) >= PATH_MAX){
+			printf("myfind: ‘%s%s%s’: File name too long\n", node->name, sep, dirzeiger->d_name);
+			continue;
+		}
+		if(!queue_push(queue, fname, node->depth + 1, 0)) {
+			closedir(dir);
+			return 0;
 		}
 	}
 	closedir(dir);
 	return 1;
 }
+/**
+ * @brief one entry of the search, to the task itself or with --queries to every line
+ *
+ */
+static int visit(struct myfind *task, char *fname, struct stat *attribut, int depth){
+	if(task->queries) return eval_queries(task, fname, attribut, depth);
+	return eval_entry(task, fname, attribut, depth, -1);
+}
+/**
+ * @brief search the tree below a starting point
+ *
+ * Iterative instead of recursive: pending entries are kept in a frontier, which
+ * is a stack (depth-first) or with -bfs a fifo (breadth-first). With -depth a
+ * directory is put back into the stack before its content, so it is listed after it.
+ * Ends as soon as task->done is set by -quit or -limit.
+ */
+int do_dir(struct myfind *task, char *dir_name) {
+	struct dirqueue queue;
+	struct dirnode *node;
+	struct stat attribut;
+	int descend, ret = 1;
+
+	queue_init(&queue, task->maxqueue, !(task->predicate & MYFIND_BFS));
+	if(!queue_push(&queue, dir_name, 0, 0)) ret = 0;
+	while(ret && !task->done && (node = queue_pop(&queue)) != NULL) {
+		if(lstat(node->name, &attribut) == -1) {
+			printf("myfind: ‘%s’: No such file or directory\n", node->name);
+		} else if(node->post) {
+			if(!visit(task, node->name, &attribut, node->depth)) ret = 0;		// content done, now the directory itself
+		} else {
+			descend = S_ISDIR(attribut.st_mode) && (task->maxdepth == 0 || node->depth < task->maxdepth);
+			if(descend && (task->predicate & MYFIND_DEPTH)) {
+				if(!queue_push(&queue, node->name, node->depth, 1)) ret = 0;
+			} else if(!visit(task, node->name, &attribut, node->depth)) {
+				ret = 0;
+			}
+			if(ret && descend && !task->done && !read_dir(&queue, node)) ret = 0;	// answer complete, don't read any further
+		}
+		free(node);
+	}
+	if(queue.error) ret = 0;
+	queue_free(&queue);
+	return ret;
+}
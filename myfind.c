@@ -34,13 +34,11 @@ int main(int argc, char *argv[]) {
 
 	//struct dirent *dirzeiger;
 	static struct myfind tasktodo = {
-			' ',
-			0,
-			NULL,
-			NULL,
-			0,				// 0 = search hole directory
-			NULL, NULL, NULL,
-			{ 0 }
+			.linkoption = ' ',
+			.maxdepth = 0,			// 0 = search hole directory
+			.maxqueue = 0,			// 0 = MYFIND_QUEUE_DEFAULT
+			.limit = 0,				// no -limit
+			.out = NULL				// stdout, unless -fprint
 	};
 
 	end_of_link_opt = find_end_of_link_opt(&tasktodo, argc, argv);												// get index of first possible filename
@@ -68,7 +66,11 @@ int main(int argc, char *argv[]) {
 		return 0;																					// filename already set, no double filename (in -name) allowed
 	}
 
-	if(!do_entry(&tasktodo)) puts("Error building tree!");
+	if(!do_entry(&tasktodo)) {
+		puts("Error building tree!");
+		freeMemory(&tasktodo);
+		return EXIT_FAILURE;
+	}
 
 	freeMemory(&tasktodo);
 	return EXIT_SUCCESS;
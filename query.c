@@ -0,0 +1,268 @@
+/**
+ * @file
+ * @brief --queries FILE: evaluate many expressions in one search
+ * @author Andreas Bauer, IC20B005
+ *
+ * Every line of the file is an expression like on the command line (without
+ * paths), parsed by parse_arguments() into a struct query. The tree is
+ * walked once and every entry is given to all of these tasks. The output of a
+ * line goes to the file of its -fprint, otherwise to FILE.N (N = line number).
+ *
+ * Tests used by several lines are done only once per entry: the entry is
+ * stat'ed once by the walker, every distinct -name pattern is matched at most
+ * once (testcache) and -user is resolved to an uid before the search starts.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "defs.h"
+
+/**
+ * @brief split a line into arguments, '...' and "..." may contain blanks
+ *
+ * The arguments are written back into the line, argv points into it.
+ * @return number of arguments, 0 if a quote isn't closed, -1 if out of memory
+ */
+static int split_line(char *line, char ***argv){
+	char *src = line, *dst = line, quote;
+	char **args, **more;
+	int argc = 1, max = 8;
+
+	if((args = malloc(sizeof(char *) * max)) == NULL) return -1;
+	args[0] = "myfind";									// parse_arguments() starts behind the program name
+	while(*src){
+		while(isspace((unsigned char)*src)) src++;
+		if(*src == '\0' || *src == '#') break;			// end of line or comment
+		if(argc + 1 >= max){
+			max *= 2;
+			if((more = realloc(args, sizeof(char *) * max)) == NULL){
+				free(args);
+				return -1;
+			}
+			args = more;
+		}
+		args[argc++] = dst;
+		quote = 0;
+		while(*src && (quote || !isspace((unsigned char)*src))){
+			if(!quote && (*src == '\'' || *src == '"')) quote = *src;
+			else if(quote && *src == quote) quote = 0;
+			else *dst++ = *src;
+			src++;
+		}
+		if(quote){										// unterminated quote, line is invalid
+			argc = 0;
+			break;
+		}
+		if(*src) src++;
+		*dst++ = '\0';
+	}
+	args[argc] = NULL;
+	*argv = args;
+	return argc;
+}
+
+/**
+ * @brief position of a -name pattern in the cache, add it if it's a new one
+ *
+ * @return -1 if out of memory
+ */
+static int cache_add(struct testcache *cache, char *name){
+	int i;
+	char **names;
+
+	for(i = 0; i < cache->count; i++){
+		if(!strcmp(cache->names[i], name)) return i;				// same pattern as an earlier line
+	}
+	if((names = realloc(cache->names, sizeof(char *) * (cache->count + 1))) == NULL) return -1;
+	cache->names = names;
+	cache->names[cache->count] = name;
+	return cache->count++;
+}
+
+/**
+ * @brief result of the pattern idx for the current entry, fnmatch() only on first use
+ *
+ */
+int cache_name(struct testcache *cache, int idx, char *base){
+	if(cache->stamp[idx] != cache->gen){
+		cache->hit[idx] = !fnmatch(cache->names[idx], base, MYFIND_FNM_FLAGS);
+		cache->stamp[idx] = cache->gen;
+	}
+	return cache->hit[idx];
+}
+
+static void free_query(struct query *query){
+	freeMemory(&query->task);
+	free(query->argv);
+	free(query->line);
+	free(query->outname);
+	free(query);
+}
+
+/**
+ * @brief parse and check one line, nothing is opened yet
+ *
+ */
+static int check_query(struct myfind *task, struct query *query, int argc, char *filename, int lineno){
+	size_t len;
+
+	if(parse_arguments(&query->task, argc, query->argv, 1) != 1){		// no paths, they belong on the command line
+		printf("myfind: %s:%d: invalid expression\n", filename, lineno);
+		return 0;
+	}
+	if(query->task.predicate & (MYFIND_DEPTH | MYFIND_BFS | MYFIND_MAXQUEUE | MYFIND_QUERIES)){
+		printf("myfind: %s:%d: -depth, -bfs, -maxqueue and --queries only work on the command line\n", filename, lineno);
+		return 0;
+	}
+	if(!set_predicates(&query->task)){
+		printf("myfind: %s:%d: invalid expression\n", filename, lineno);
+		return 0;
+	}
+	if(query->task.fprint == NULL){										// no -fprint, output to FILE.N
+		len = strlen(filename) + 16;
+		if((query->outname = malloc(len)) == NULL){
+			puts("myfind: out of memory\n");
+			return 0;
+		}
+		if(snprintf(query->outname, len, "%s.%d", filename, lineno) >= PATH_MAX){
+			printf("myfind: ‘%s’: File name too long\n", query->outname);
+			return 0;
+		}
+		query->task.fprint = query->outname;
+	}
+	if(query->task.name && (query->nameidx = cache_add(task->cache, query->task.name)) < 0){
+		puts("myfind: out of memory\n");
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief each line needs an output file of its own, or the lines overwrite each other
+ *
+ * Compares the names as given (-fprint or FILE.N), not the files they resolve to.
+ */
+static int unique_output(struct myfind *task, struct query *query, char *filename, int lineno){
+	struct query *other;
+
+	for(other = task->queries; other != NULL; other = other->next){
+		if(!strcmp(other->task.fprint, query->task.fprint)){
+			printf("myfind: %s:%d: output file ‘%s’ is already used in line %d\n", filename, lineno, query->task.fprint, other->lineno);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief read the file and make a task of every line
+ *
+ * All lines are checked before the first output file is opened, so a bad
+ * line doesn't leave truncated results of an earlier run behind.
+ */
+int load_queries(struct myfind *task, char *filename){
+	FILE *fp;
+	char *line = NULL;
+	size_t size = 0;
+	struct query *query, *last = NULL;
+	int argc, lineno = 0, walkdepth = 0, unlimited = 0, ok = 1;
+
+	if((fp = fopen(filename, "r")) == NULL){
+		printf("myfind: ‘%s’: No such file or directory\n", filename);
+		return 0;
+	}
+	if((task->cache = calloc(1, sizeof(struct testcache))) == NULL){
+		fclose(fp);
+		puts("myfind: out of memory\n");
+		return 0;
+	}
+	while(getline(&line, &size, fp) != -1){
+		lineno++;
+		if((query = calloc(1, sizeof(struct query))) == NULL || (query->line = malloc(strlen(line) + 1)) == NULL){
+			free(query);
+			puts("myfind: out of memory\n");
+			ok = 0;
+			break;
+		}
+		query->task.linkoption = task->linkoption;
+		strcpy(query->line, line);
+		if((argc = split_line(query->line, &query->argv)) < 0){
+			puts("myfind: out of memory\n");
+			free_query(query);
+			ok = 0;
+			break;
+		}
+		if(argc == 0) printf("myfind: %s:%d: invalid expression, missing quote\n", filename, lineno);
+		if(argc <= 1 || !check_query(task, query, argc, filename, lineno) || !unique_output(task, query, filename, lineno)){
+			if(argc != 1) ok = 0;										// go on, to report every bad line
+			free_query(query);											// empty line, comment or bad line
+			continue;
+		}
+		query->lineno = lineno;
+		if(last) last->next = query; else task->queries = query;
+		last = query;
+		if(query->task.maxdepth == 0) unlimited = 1;
+		else if(query->task.maxdepth > walkdepth) walkdepth = query->task.maxdepth;
+	}
+	free(line);
+	fclose(fp);
+	if(!ok) return 0;
+	if(task->queries == NULL){
+		printf("myfind: ‘%s’: no queries\n", filename);
+		return 0;
+	}
+	for(query = task->queries; query != NULL; query = query->next){
+		if(!open_output(&query->task)) return 0;
+	}
+	task->cache->hit = malloc(task->cache->count + 1);
+	task->cache->stamp = malloc(sizeof(long) * (task->cache->count + 1));
+	if(!task->cache->hit || !task->cache->stamp){
+		puts("myfind: out of memory\n");
+		return 0;
+	}
+	memset(task->cache->stamp, 0, sizeof(long) * (task->cache->count + 1));
+	if(unlimited) walkdepth = 0;									// walk as deep as the deepest line needs
+	if(task->maxdepth == 0 || (walkdepth && walkdepth < task->maxdepth)) task->maxdepth = walkdepth;
+	return 1;
+}
+
+/**
+ * @brief give one entry to every line that is not done yet
+ *
+ * @return 0 on error of one of the lines
+ */
+int eval_queries(struct myfind *task, char *fname, struct stat *attribut, int depth){
+	struct query *query;
+	char *base = base_name(fname);
+	int open = 0, namehit;
+
+	task->cache->gen++;									// new entry, forget the results of the patterns
+	for(query = task->queries; query != NULL; query = query->next){
+		if(query->task.done) continue;
+		namehit = query->task.name ? cache_name(task->cache, query->nameidx, base) : -1;	// same pattern only once per entry
+		if(!eval_entry(&query->task, fname, attribut, depth, namehit)) return 0;
+		if(!query->task.done) open++;
+	}
+	if(!open) task->done = 1;							// every line has its answer, stop the search
+	return 1;
+}
+
+void free_queries(struct myfind *task){
+	struct query *query = task->queries, *temp;
+
+	while(query != NULL){
+		temp = query->next;
+		free_query(query);
+		query = temp;
+	}
+	task->queries = NULL;
+	if(task->cache){
+		free(task->cache->names);
+		free(task->cache->hit);
+		free(task->cache->stamp);
+		free(task->cache);
+		task->cache = NULL;
+	}
+}
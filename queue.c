@@ -0,0 +1,209 @@
+/**
+ * @file
+ * @brief Frontier of the directory traversal with spill-to-disk
+ * @author Andreas Bauer, IC20B005
+ *
+ * The entries still to be visited are kept in a doubly linked list. As soon as
+ * more than limit entries are pending, the rest is written to a temp file, so
+ * the memory used by the search doesn't grow with the width of the tree.
+ *
+ * fifo (-bfs): memory holds the oldest entries, new entries go to the end of the
+ * temp file as long as it is not empty. If memory runs empty, the next records
+ * are read from the front of the file.
+ *
+ * stack: if memory is full, the older half of the list is appended to the file.
+ * If memory runs empty, records are read back from the end of the file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "defs.h"
+
+/**
+ * @struct spillrec
+ * @brief header of an entry in the temp file, followed (fifo) or preceded (stack) by the path
+ *
+ */
+struct spillrec {
+	int depth;
+	char post;
+	size_t len;				// length of the path without '\0'
+};
+
+static struct dirnode *new_node(const char *name, size_t len, int depth, char post){
+	struct dirnode *node;
+
+	node = malloc(sizeof(struct dirnode) + len + 1);
+	if(!node){
+		puts("myfind: out of memory\n");
+		return NULL;
+	}
+	memcpy(node->name, name, len);
+	node->name[len] = '\0';
+	node->depth = depth;
+	node->post = post;
+	node->next = node->prev = NULL;
+	return node;
+}
+
+static void link_tail(struct dirqueue *queue, struct dirnode *node){
+	node->next = NULL;
+	node->prev = queue->tail;
+	if(queue->tail) queue->tail->next = node; else queue->head = node;
+	queue->tail = node;
+	queue->count++;
+}
+
+static void link_head(struct dirqueue *queue, struct dirnode *node){
+	node->prev = NULL;
+	node->next = queue->head;
+	if(queue->head) queue->head->prev = node; else queue->tail = node;
+	queue->head = node;
+	queue->count++;
+}
+
+static struct dirnode *unlink_node(struct dirqueue *queue, struct dirnode *node){
+	if(node->prev) node->prev->next = node->next; else queue->head = node->next;
+	if(node->next) node->next->prev = node->prev; else queue->tail = node->prev;
+	node->next = node->prev = NULL;
+	queue->count--;
+	return node;
+}
+
+static int spill_error(struct dirqueue *queue){
+	puts("myfind: can't use temp file for pending directories\n");
+	queue->error = 1;
+	return 0;
+}
+
+/**
+ * @brief append one entry at the end of the temp file
+ *
+ */
+static int spill_write(struct dirqueue *queue, struct dirnode *node){
+	struct spillrec rec;
+
+	if(queue->spill == NULL && (queue->spill = tmpfile()) == NULL) return spill_error(queue);
+	rec.depth = node->depth;
+	rec.post = node->post;
+	rec.len = strlen(node->name);
+	if(fseek(queue->spill, queue->wpos, SEEK_SET) != 0) return spill_error(queue);
+	if(!queue->lifo && fwrite(&rec, sizeof(rec), 1, queue->spill) != 1) return spill_error(queue);
+	if(fwrite(node->name, 1, rec.len, queue->spill) != rec.len) return spill_error(queue);
+	if(queue->lifo && fwrite(&rec, sizeof(rec), 1, queue->spill) != 1) return spill_error(queue);
+	queue->wpos += sizeof(rec) + rec.len;
+	queue->spilled++;
+	return 1;
+}
+
+/**
+ * @brief read up to max entries back from the temp file into memory
+ *
+ */
+static int spill_read(struct dirqueue *queue, long max){
+	struct spillrec rec;
+	struct dirnode *node;
+	char name[PATH_MAX];
+
+	while(queue->spilled > 0 && max-- > 0){
+		if(queue->lifo){													// last record first, header behind the path
+			if(fseek(queue->spill, queue->wpos - (long)sizeof(rec), SEEK_SET) != 0) return spill_error(queue);
+			if(fread(&rec, sizeof(rec), 1, queue->spill) != 1 || rec.len >= PATH_MAX) return spill_error(queue);
+			queue->wpos -= sizeof(rec) + rec.len;
+			if(fseek(queue->spill, queue->wpos, SEEK_SET) != 0) return spill_error(queue);
+			if(fread(name, 1, rec.len, queue->spill) != rec.len) return spill_error(queue);
+		} else {															// first record first, header in front of the path
+			if(fseek(queue->spill, queue->rpos, SEEK_SET) != 0) return spill_error(queue);
+			if(fread(&rec, sizeof(rec), 1, queue->spill) != 1 || rec.len >= PATH_MAX) return spill_error(queue);
+			if(fread(name, 1, rec.len, queue->spill) != rec.len) return spill_error(queue);
+			queue->rpos += sizeof(rec) + rec.len;
+		}
+		queue->spilled--;
+		if((node = new_node(name, rec.len, rec.depth, rec.post)) == NULL){
+			queue->error = 1;
+			return 0;
+		}
+		if(queue->lifo) link_head(queue, node); else link_tail(queue, node);	// stack: older ones below the newer ones
+	}
+	if(queue->spilled == 0) queue->rpos = queue->wpos = 0;				// file is empty, start from the beginning
+	return 1;
+}
+
+/**
+ * @brief prepare an empty frontier
+ *
+ * @param limit	max. entries in memory, 0 = MYFIND_QUEUE_DEFAULT
+ * @param lifo	1 = stack for depth-first, 0 = fifo for breadth-first
+ */
+int queue_init(struct dirqueue *queue, long limit, int lifo){
+	memset(queue, 0, sizeof(struct dirqueue));
+	if(limit <= 0) limit = MYFIND_QUEUE_DEFAULT;
+	queue->limit = limit < 2 ? 2 : limit;		// stack spills half of it, so at least one has to stay (-maxqueue checks this too)
+	queue->lifo = lifo;
+	return 1;
+}
+
+/**
+ * @brief add a pending entry
+ *
+ * @return 0 if out of memory or the temp file failed
+ */
+int queue_push(struct dirqueue *queue, const char *name, int depth, char post){
+	struct dirnode *node;
+	long half;
+	int ok;
+
+	if((node = new_node(name, strlen(name), depth, post)) == NULL){
+		queue->error = 1;
+		return 0;
+	}
+	if(!queue->lifo){
+		if(queue->spilled == 0 && queue->count < queue->limit){
+			link_tail(queue, node);
+			return 1;
+		}
+		ok = spill_write(queue, node);			// fifo: keep order, newer ones behind the ones in the file
+		free(node);
+		return ok;
+	}
+	link_tail(queue, node);
+	if(queue->count > queue->limit){			// stack: move the older half to the file
+		half = queue->count / 2;
+		while(half-- > 0){
+			node = unlink_node(queue, queue->head);
+			ok = spill_write(queue, node);
+			free(node);
+			if(!ok) return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief take the next entry, the caller has to free it
+ *
+ * @return NULL if the frontier is empty (or on error, see queue->error)
+ */
+struct dirnode *queue_pop(struct dirqueue *queue){
+	if(queue->count == 0 && queue->spilled > 0){
+		if(!spill_read(queue, queue->lifo ? queue->limit / 2 : queue->limit)) return NULL;
+	}
+	if(queue->count == 0) return NULL;
+	return unlink_node(queue, queue->lifo ? queue->tail : queue->head);
+}
+
+void queue_free(struct dirqueue *queue){
+	struct dirnode *node;
+
+	while(queue->head != NULL){
+		node = queue->head;
+		queue->head = node->next;
+		free(node);
+	}
+	queue->tail = NULL;
+	queue->count = 0;
+	if(queue->spill) fclose(queue->spill);
+	queue->spill = NULL;
+	queue->spilled = 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * @file
+ * @brief -top N: keep only the N largest/newest matches
+ * @author Andreas Bauer, IC20B005
+ *
+ * The matches are kept in a min-heap of at most N entries, the weakest one on
+ * top. A new match either replaces it or is dropped right away, so memory
+ * depends on the matches kept, not on the number of matches.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "defs.h"
+
+#define TOPK_START 16			// first allocation, doubled until max is reached
+
+static long long get_key(struct stat *attribut, int by){
+	if(by == MYFIND_BY_MTIME) return (long long)attribut->st_mtim.tv_sec * 1000000000LL + attribut->st_mtim.tv_nsec;
+	return (long long)attribut->st_size;
+}
+
+/**
+ * @brief is a weaker than b? equal keys are ordered by name
+ *
+ */
+static int weaker(struct topentry *a, struct topentry *b){
+	if(a->key != b->key) return a->key < b->key;
+	return strcmp(a->name, b->name) > 0;
+}
+
+static void swap_entry(struct topentry *a, struct topentry *b){
+	struct topentry temp = *a;
+	*a = *b;
+	*b = temp;
+}
+
+static void sift_up(struct topk *top, long i){
+	long parent;
+
+	while(i > 0){
+		parent = (i - 1) / 2;
+		if(!weaker(&top->heap[i], &top->heap[parent])) break;
+		swap_entry(&top->heap[i], &top->heap[parent]);
+		i = parent;
+	}
+}
+
+static void sift_down(struct topk *top, long i){
+	long child;
+
+	while((child = 2 * i + 1) < top->size){
+		if(child + 1 < top->size && weaker(&top->heap[child + 1], &top->heap[child])) child++;
+		if(!weaker(&top->heap[child], &top->heap[i])) break;
+		swap_entry(&top->heap[i], &top->heap[child]);
+		i = child;
+	}
+}
+
+/**
+ * @brief empty heap for max entries
+ *
+ * Memory is allocated as matches come in, so a large N costs nothing up front.
+ * @return NULL if out of memory
+ */
+struct topk *topk_new(long max, int by){
+	struct topk *top;
+
+	top = malloc(sizeof(struct topk));
+	if(!top) return NULL;
+	top->heap = NULL;
+	top->size = 0;
+	top->cap = 0;
+	top->max = max;
+	top->by = by;
+	return top;
+}
+
+/**
+ * @brief make room for one more entry
+ *
+ */
+static int grow(struct topk *top){
+	struct topentry *heap;
+	long cap;
+
+	cap = top->cap == 0 ? TOPK_START : (top->cap > top->max / 2 ? top->max : top->cap * 2);
+	if(cap > top->max) cap = top->max;
+	if((size_t)cap > SIZE_MAX / sizeof(struct topentry)) return 0;
+	if((heap = realloc(top->heap, sizeof(struct topentry) * cap)) == NULL) return 0;
+	top->heap = heap;
+	top->cap = cap;
+	return 1;
+}
+
+/**
+ * @brief offer a match to the heap
+ *
+ * @return 0 if out of memory
+ */
+int topk_add(struct topk *top, char *fname, struct stat *attribut){
+	struct topentry entry;
+
+	entry.key = get_key(attribut, top->by);
+	entry.name = fname;
+	if(top->size == top->max && !weaker(&top->heap[0], &entry)) return 1;	// not better than the weakest one, drop it
+	if((top->size == top->cap && top->size < top->max && !grow(top)) || (entry.name = malloc(strlen(fname) + 1)) == NULL){
+		puts("myfind: out of memory\n");
+		return 0;
+	}
+	strcpy(entry.name, fname);
+	memcpy(&entry.filestat, attribut, sizeof(struct stat));
+	if(top->size < top->max){
+		top->heap[top->size] = entry;
+		sift_up(top, top->size++);
+	} else {
+		free(top->heap[0].name);
+		top->heap[0] = entry;
+		sift_down(top, 0);
+	}
+	return 1;
+}
+
+/**
+ * @brief output the kept matches, best one first
+ *
+ * Sorts the heap in place, so it's empty afterwards.
+ */
+int topk_print(struct myfind *task, struct topk *top){
+	long i, n = top->size;
+
+	while(top->size > 1){									// weakest one to the end, then the next one...
+		swap_entry(&top->heap[0], &top->heap[--top->size]);
+		sift_down(top, 0);
+	}
+	top->size = 0;
+	for(i = 0; i < n; i++){
+		print_lstat(task, &top->heap[i].filestat, top->heap[i].name);
+		free(top->heap[i].name);
+	}
+	return 1;
+}
+
+void topk_free(struct topk *top){
+	long i;
+
+	if(top == NULL) return;
+	for(i = 0; i < top->size; i++) free(top->heap[i].name);
+	free(top->heap);
+	free(top);
+}
@@ -22,7 +22,7 @@ int doesitmatch(struct myfind *task, char *name, int type){
 	while(mypred != NULL){
 		arg = mypred->args;
 		if(mypred->predicate == type){
-			if(!fnmatch(arg->argument, name, FNM_NOESCAPE | FNM_PERIOD)){
+			if(!fnmatch(arg->argument, name, MYFIND_FNM_FLAGS)){
 				return type;
 			}
 		}
@@ -125,6 +125,15 @@ int parse_arguments(struct myfind *task, int argc, char *argv[], int end_of_link
 			{"-print", MYFIND_PRINT, 1},
 			{"-ls", MYFIND_LS, 0},
 			{"-maxdepth", MYFIND_MAXDEPTH, 1},
+			{"-depth", MYFIND_DEPTH, 0},
+			{"-bfs", MYFIND_BFS, 0},
+			{"-maxqueue", MYFIND_MAXQUEUE, 1},
+			{"-quit", MYFIND_QUIT, 0},
+			{"-limit", MYFIND_LIMIT, 1},
+			{"-top", MYFIND_TOP, 1},
+			{"-by", MYFIND_BY, 1},
+			{"-fprint", MYFIND_FPRINT, 1},
+			{"--queries", MYFIND_QUERIES, 1},
 			{"--help", MYFIND_HELP, 0},
 			{"END", 0, 0}
 	};
@@ -186,6 +195,33 @@ int parse_arguments(struct myfind *task, int argc, char *argv[], int end_of_link
 						mypred->predicate = MYFIND_MAXDEPTH;
 						if(i<(argc-1))task->maxdepth = (atoi(argv[i+1]) < 0 ? 0 : atoi(argv[i+1]));		// something comming after '-maxdepth' ?
 						break;
+					case MYFIND_DEPTH:
+						mypred->predicate = MYFIND_DEPTH;
+						break;
+					case MYFIND_BFS:
+						mypred->predicate = MYFIND_BFS;
+						break;
+					case MYFIND_MAXQUEUE:
+						mypred->predicate = MYFIND_MAXQUEUE;
+						break;
+					case MYFIND_QUIT:
+						mypred->predicate = MYFIND_QUIT;
+						break;
+					case MYFIND_LIMIT:
+						mypred->predicate = MYFIND_LIMIT;
+						break;
+					case MYFIND_TOP:
+						mypred->predicate = MYFIND_TOP;
+						break;
+					case MYFIND_BY:
+						mypred->predicate = MYFIND_BY;
+						break;
+					case MYFIND_FPRINT:
+						mypred->predicate = MYFIND_FPRINT;
+						break;
+					case MYFIND_QUERIES:
+						mypred->predicate = MYFIND_QUERIES;
+						break;
 					default:
 						printf("myfind: unknown predicate `%s'\n",argv[i]);
 						return 0;
@@ -329,6 +365,13 @@ void freeMemory(struct myfind *task){
 		free(mypredicate);
 		mypredicate = temp1;
 	}
+	task->fileinfo = NULL;
+	task->mypred = NULL;
+	topk_free(task->top);
+	task->top = NULL;
+	if(task->out != NULL && task->out != stdout) fclose(task->out);
+	task->out = NULL;
+	free_queries(task);
 }
 void printHelp(){
 	puts("\nUsage: .\\myfind [-H] [-L] [-P] [path...] [expression]\n"
@@ -340,6 +383,7 @@ void printHelp(){
 			"positional options (always true): -daystart -follow -regextype\n"
 			"\n"
 			"normal options (always true, specified before other expressions):\n"
+			"-bfs -maxqueue ENTRIES (at least 2) --queries FILE\n"
 			"-depth --help -maxdepth LEVELS -mindepth LEVELS -mount -noleaf\n"
 			"--version -xdev -ignore_readdir_race -noignore_readdir_race\n"
 			"tests (N can be +N or -N or N): -amin N -anewer FILE -atime N -cmin N\n"
@@ -353,6 +397,7 @@ void printHelp(){
 			"\n"
 			"actions: -delete -print0 -printf FORMAT -fprintf FILE FORMAT -print\n"
 			"-fprint0 FILE -fprint FILE -ls -fls FILE -prune -quit\n"
+			"-limit N -top N [-by size|mtime]\n"
 			"-exec COMMAND ; -exec COMMAND {} + -ok COMMAND ;\n"
 			"-execdir COMMAND ; -execdir COMMAND {} + -okdir COMMAND ;\n"
 			"\n"